@@ -0,0 +1,110 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pthreader.h"
+
+// measures the round trip cost of evaluate() itself: every thread runs an empty kernel, so 
+// all of the time is spent handing out work and learning that it is done
+
+int pt_dispatch_evaluation( int n , void * data , void * in , void * out ) { return 0; }
+
+double now_us() 
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC , &ts );
+	return 1.0e6 * ((double)ts.tv_sec) + 1.0e-3 * ((double)ts.tv_nsec);
+}
+
+int compare_doubles( const void * a , const void * b )
+{
+	double x = *(( const double * )a) , y = *(( const double * )b);
+	return ( x < y ? -1 : ( x > y ? 1 : 0 ) );
+}
+
+int main( int argc , char * argv[] ) 
+{
+	// read T, iterations, and the dispatch engine from CL args (and, optionally, the wait policy)
+
+	if( argc < 4 ) {
+		printf( "\"%s\" expects three arguments: Number of Threads, Number of Evaluations, and dispatch engine (condvar/epoch/tree), and optionally a wait policy (block/spin/poll)\n" , argv[0] );
+		return 1;
+	}
+
+	int Nthrd = (int)strtol( argv[1] , NULL , 10 );
+	int Niter = (int)strtol( argv[2] , NULL , 10 );
+
+	pthreader_dispatch dispatch;
+	if( strcmp( argv[3] , "condvar" ) == 0 ) { dispatch = PTHREADER_DISPATCH_CONDVAR; }
+	else if( strcmp( argv[3] , "epoch" ) == 0 ) { dispatch = PTHREADER_DISPATCH_EPOCH; }
+	else if( strcmp( argv[3] , "tree" ) == 0 ) { dispatch = PTHREADER_DISPATCH_TREE; }
+	else {
+		printf( "\"%s\" expects the dispatch engine to be \"condvar\", \"epoch\" or \"tree\"\n" , argv[0] );
+		return 1;
+	}
+
+	pthreader_wait_policy wait = PTHREADER_WAIT_BLOCK;
+	const char * wait_name = "block";
+	if( argc > 4 ) {
+		wait_name = argv[4];
+		if( strcmp( argv[4] , "spin" ) == 0 ) { wait = PTHREADER_WAIT_SPIN; }
+		else if( strcmp( argv[4] , "poll" ) == 0 ) { wait = PTHREADER_WAIT_POLL; }
+		else if( strcmp( argv[4] , "block" ) != 0 ) {
+			printf( "\"%s\" expects the wait policy to be \"block\", \"spin\" or \"poll\"\n" , argv[0] );
+			return 1;
+		}
+	}
+
+	if( Nthrd <= 1 || Niter <= 0 ) { 
+		printf( "\"%s\" expects at least two threads and one evaluation\n" , argv[0] );
+		return 1;
+	}
+
+	pthreader * PT = new pthreader( Nthrd , dispatch );
+	PT->set_evaluate( pt_dispatch_evaluation );
+	PT->set_wait_policy( wait );
+	PT->launch();
+
+	double * L = ( double * )malloc( Niter * sizeof( double ) );
+	double S = 0.0 , t0;
+
+	// warm up, so the threads have all been scheduled at least once
+	for( int i = 0 ; i < 100 ; i++ ) { PT->evaluate( NULL , NULL ); }
+	PT->reset_wait_stats();
+
+	for( int i = 0 ; i < Niter ; i++ ) {
+		t0 = now_us();
+		PT->evaluate( NULL , NULL );
+		L[i] = now_us() - t0;
+		S += L[i];
+	}
+
+	// spins and parks per evaluation, for the master (the join side) and summed over the workers
+	pthreader_wait_stats ws;
+	double master_spins , master_parks , worker_spins = 0.0 , worker_parks = 0.0;
+	PT->get_wait_stats( 0 , &ws );
+	master_spins = ((double)ws.spins) / ((double)ws.evaluations);
+	master_parks = ((double)ws.parks) / ((double)ws.evaluations);
+	for( int t = 1 ; t < Nthrd ; t++ ) {
+		PT->get_wait_stats( t , &ws );
+		worker_spins += ((double)ws.spins) / ((double)ws.evaluations);
+		worker_parks += ((double)ws.parks) / ((double)ws.evaluations);
+	}
+
+	PT->close();
+	delete PT;
+
+	qsort( L , Niter , sizeof( double ) , compare_doubles );
+
+	printf( "engine,wait,threads,evaluations,mean_us,p50_us,p90_us,p99_us,max_us,master_spins,master_parks,worker_spins,worker_parks\n" );
+	printf( "%s,%s,%i,%i,%0.3f,%0.3f,%0.3f,%0.3f,%0.3f,%0.1f,%0.3f,%0.1f,%0.3f\n" , argv[3] , wait_name , Nthrd , Niter , S / ((double)Niter) , 
+				L[Niter/2] , L[(9*Niter)/10] , L[(99*Niter)/100] , L[Niter-1] , 
+				master_spins , master_parks , worker_spins , worker_parks );
+
+	free( L );
+
+	return 0;
+
+}
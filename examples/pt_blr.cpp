@@ -1,6 +1,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "pthreader.h"
@@ -95,10 +96,10 @@ int pt_blr_evaluation( int n , void * data , void * in , void * out )
 
 int main( int argc , char * argv[] ) 
 {
-	// read T, N, K, and const from CL args
+	// read T, N, K, and const from CL args (and, optionally, the dispatch engine)
 
 	if( argc < 5 ) {
-		printf( "\"%s\" expects four arguments: Number of Threads, Number of Observations, Number of Features, and Constant (yes/no)\n" , argv[0] );
+		printf( "\"%s\" expects four arguments: Number of Threads, Number of Observations, Number of Features, and Constant (yes/no), and optionally a dispatch engine (condvar/epoch/tree)\n" , argv[0] );
 		return 1;
 	}
 
@@ -109,6 +110,16 @@ int main( int argc , char * argv[] )
 	params.Nfeat = (int)strtol( argv[3] , NULL , 10 );
 	params.Nvars = params.Nfeat + ( (int)strtol( argv[4] , NULL , 10 ) ? 1 : 0 );
 
+	pthreader_dispatch dispatch = PTHREADER_DISPATCH_CONDVAR;
+	if( argc > 5 ) {
+		if( strcmp( argv[5] , "epoch" ) == 0 ) { dispatch = PTHREADER_DISPATCH_EPOCH; }
+		else if( strcmp( argv[5] , "tree" ) == 0 ) { dispatch = PTHREADER_DISPATCH_TREE; }
+		else if( strcmp( argv[5] , "condvar" ) != 0 ) {
+			printf( "\"%s\" expects the dispatch engine to be \"condvar\", \"epoch\" or \"tree\"\n" , argv[0] );
+			return 1;
+		}
+	}
+
 	if( params.Nthrd <= 1 ) { 
 		printf( "\"%s\" expects at least two threads\n" , argv[0] );
 		return 1;
@@ -129,7 +140,7 @@ int main( int argc , char * argv[] )
 	for( int i = 0 ; i < params.Nvars ; i++ ) { (params.c)[i] = 2.0 * urand() - 1.0; }
 
 	// create a new pthreader object with the number of threads
-	pthreader * PT = new pthreader( params.Nthrd );
+	pthreader * PT = new pthreader( params.Nthrd , dispatch );
 
 	// print out what is happening during setup
 	PT->be_verbose();
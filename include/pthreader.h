@@ -16,6 +16,7 @@
  * TEMPLATE FOR USE: 
  * 
  * 		pthreader * PT = new pthreader( T );	// create a new object with T threads (total, launches T-1)
+ *												// (or pthreader( T , PTHREADER_DISPATCH_EPOCH ) to pick the engine)
  * 		
  *		PT->set_setup( my_setup );				// define the per-thread setup function
  *		PT->set_evaluation( my_evaluation );	// define the per-thread evaluation function
@@ -79,6 +80,10 @@
 #include <stdio.h>
 #include <pthread.h>
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -126,6 +131,166 @@ typedef int (*pthreader_eval_fcn)( int , void * , void * , void * );
 // other functions will get the thread number and the pointer returned from a previous, in-thread call to setup
 typedef void (*pthreader_free_fcn)( int , void ** );
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * DISPATCH ENGINES
+ * 
+ * How evaluate() hands work to the threads and learns that they are done. 
+ * 
+ * 		PTHREADER_DISPATCH_CONDVAR 	one mutex and two condition variables per thread; the master locks, 
+ * 									signals and waits on each thread in turn (the original model)
+ * 
+ * 		PTHREADER_DISPATCH_EPOCH 	the master bumps one shared generation counter and threads report 
+ * 									completion through one shared atomic countdown; sleeping threads 
+ * 									park on the counters themselves (futexes, on linux)
+ * 
+ * 		PTHREADER_DISPATCH_TREE 	threads form a tree rooted at the master (PTHREADER_TREE_FANOUT 
+ * 									children each). Every thread wakes its children, evaluates, waits 
+ * 									for its children and folds their status into its own before 
+ * 									reporting to its parent, so dispatch and join are both O(log T)
+ * 
+ * The engine is chosen at construction and can't be changed for a live object. 
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef enum pthreader_dispatch {
+	PTHREADER_DISPATCH_CONDVAR = 0,
+	PTHREADER_DISPATCH_EPOCH   = 1,
+	PTHREADER_DISPATCH_TREE    = 2
+} pthreader_dispatch;
+
+// children per thread in the tree engine (thread t's children are FANOUT*t+1 through FANOUT*t+FANOUT)
+#define PTHREADER_TREE_FANOUT 2
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * WAIT POLICIES
+ * 
+ * What a thread does while it waits, both workers waiting for work and the master waiting for workers. 
+ * 
+ * 		PTHREADER_WAIT_BLOCK 	go straight to sleep (condition variable or futex), the default
+ * 
+ * 		PTHREADER_WAIT_SPIN 	spin (with a cpu "pause") up to a bounded number of times, then sleep
+ * 
+ * 		PTHREADER_WAIT_POLL 	spin until released, never sleep; lowest latency, but every waiting 
+ * 								thread burns a whole core
+ * 
+ * Waking a sleeping thread costs microseconds, so spinning pays when evaluations are short and frequent. 
+ * get_wait_stats() counts spin iterations and sleeps ("parks") per thread to help choose. 
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef enum pthreader_wait_policy {
+	PTHREADER_WAIT_BLOCK = 0,
+	PTHREADER_WAIT_SPIN  = 1,
+	PTHREADER_WAIT_POLL  = 2
+} pthreader_wait_policy;
+
+// default bound on spin iterations before sleeping, for PTHREADER_WAIT_SPIN
+#define PTHREADER_WAIT_SPINS 4000
+
+// wait counters for one thread
+typedef struct pthreader_wait_stats {
+	long evaluations;			// evaluations since the counters were last reset
+	long waits;					// times the thread had to wait at all
+	long spins;					// total spin iterations while waiting
+	long parks;					// times the thread went to sleep while waiting
+} pthreader_wait_stats;
+
+// a word threads wait on, with a count of the threads asleep on it so waking is free when nobody sleeps
+typedef struct pthreader_word {
+	int value;
+	int sleepers;
+} pthreader_word;
+
+// evaluation status, folded into bits so it can be combined up a tree: a set of statuses is summarized
+// by which signs were seen, and all the any/all status checks can be answered from that
+#define PTHREADER_STATUS_SEEN_ZERO 1
+#define PTHREADER_STATUS_SEEN_POS  2
+#define PTHREADER_STATUS_SEEN_NEG  4
+
+// the work published to every thread by the epoch engine, one "generation" at a time
+typedef struct pthreader_job {
+	int exit;						// exit flag; threads clean up and exit instead of evaluating
+	pthreader_eval_fcn thread_eval; // evaluate function handle for this generation
+	void * eval_in; 				// data for evaluation, passed through evaluation
+	void * eval_out; 				// data for evaluation results, passed through evaluation
+} pthreader_job;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * THREAD PLACEMENT
+ * 
+ * Where launch() pins each thread (the master, thread 0, included). Left alone, the kernel places threads 
+ * wherever it likes and migrates them mid-run, which undoes the locality of "each thread allocates its 
+ * own data". Placements are orderings of the cpus we are allowed to run on; thread t gets the t'th. 
+ * 
+ * 		PTHREADER_PLACE_NONE 	don't pin anything (the default)
+ * 
+ * 		PTHREADER_PLACE_COMPACT 	fill each core's hyperthreads, then the next core, then the next package,
+ * 								so neighbouring threads share as much cache as possible
+ * 
+ * 		PTHREADER_PLACE_SCATTER 	spread threads round-robin over NUMA nodes, one per physical core first
+ * 
+ * 		PTHREADER_PLACE_CORES 	one thread per physical core before doubling up on any hyperthreads
+ * 
+ * 		PTHREADER_PLACE_LIST 	an explicit list of cpus, given to set_placement()
+ * 
+ * Topology comes from sysfs (/sys/devices/system/cpu), restricted to sched_getaffinity's mask. 
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+typedef enum pthreader_placement {
+	PTHREADER_PLACE_NONE    = 0,
+	PTHREADER_PLACE_COMPACT = 1,
+	PTHREADER_PLACE_SCATTER = 2,
+	PTHREADER_PLACE_CORES   = 3,
+	PTHREADER_PLACE_LIST    = 4
+} pthreader_placement;
+
+// one usable cpu and where it sits
+typedef struct pthreader_cpu {
+	int cpu;					// the cpu (as numbered by the kernel)
+	int core;					// physical core id (unique only within a package)
+	int package;				// physical package ("socket")
+	int node;					// NUMA node
+} pthreader_cpu;
+
+// the cpus this process may run on
+typedef struct pthreader_topology {
+	int n_cpus;
+	int n_cores;
+	int n_packages;
+	int n_nodes;
+	pthreader_cpu * cpus;		// n_cpus long
+} pthreader_topology;
+
+// fill in the usable cpus' topology (returns 0 on success); free with pthreader_topology_free
+int pthreader_topology_discover( pthreader_topology * topo );
+void pthreader_topology_free( pthreader_topology * topo );
+
+// sort a discovered topology's cpus into the order a placement assigns them (returns 0 on success)
+int pthreader_placement_order( pthreader_placement p , pthreader_topology * topo );
+
+// a sensible thread count: the cpus in our affinity mask, capped by any cgroup cpu quota
+int pthreader_default_threads();
+
+// the cpu the calling thread was pinned to by launch(), or -1 if it wasn't (callable from setup, 
+// evaluate and cleanup functions, in any thread)
+int pthreader_thread_cpu();
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -136,13 +301,52 @@ typedef void (*pthreader_free_fcn)( int , void ** );
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-// this datatype holds data needed by the generic thread evaluation
-typedef struct pthreader_params {
+// the size of a cache line; anything one thread writes often and others read is padded out to these
+#define PTHREADER_CACHE_LINE 64
+
+// what the epoch engine shares among all the threads. The generation counter and job are written only by 
+// the master, the countdown by everybody, so the countdown gets a line of its own. 
+typedef struct alignas(PTHREADER_CACHE_LINE) pthreader_shared {
+
+	pthreader_word epoch;		// generation counter
+	pthreader_job job;			// the job for the current generation
+
+	alignas(PTHREADER_CACHE_LINE) pthreader_word pending; // count of threads still working on this generation
+
+} pthreader_shared;
+
+// this datatype holds data needed by the generic thread evaluation. It is the thread's "control block": 
+// its flags, status, evaluation pointers and synchronization primitives live here, in-line, rather than in 
+// arrays shared with the other threads. Each block is aligned and padded to whole cache lines, and gets a 
+// page of its own (which the thread moves to its own NUMA node), so no two threads ever share a line. 
+typedef struct alignas(PTHREADER_CACHE_LINE) pthreader_params {
+
+	// the dispatch "hot" part, touched by this thread and the master on every evaluation
+
+	int work;					// flag indicating if there is work to do (condvar dispatch)
+	int status;					// evaluation status from this thread
+	void * eval_in; 			// data for evaluation, passed through evaluation
+	void * eval_out; 			// data for evaluation results, passed through evaluation
+
+	pthreader_word gen;			// generation this thread has been woken for (tree dispatch)
+	pthreader_word done;		// generation this thread's whole subtree has finished (tree dispatch)
+	int bits;					// status bits over this thread's whole subtree (tree dispatch)
+
+	int wait_policy;			// a pthreader_wait_policy, for this thread's waits
+	int wait_spins;				// bound on spin iterations before sleeping (PTHREADER_WAIT_SPIN)
+	pthreader_wait_stats wait_stats; // written only by this thread
+
+	pthread_mutex_t worklock; 	// lock to ensure mutual exclusivity of work in shared memory (condvar dispatch)
+	pthread_cond_t cv_work; 	// condition variable indicating work to do (condvar dispatch)
+	pthread_cond_t cv_free; 	// condition variable indicating work done (condvar dispatch)
+
+	// the "cold" part, fixed while the threads are running
 
 	int exit;					// exitflag
 	int thrd;					// thread identifier
 	int nthd;					// number of threads
 	int prnt;					// "print", like the verbose flag
+	int cpu;					// cpu this thread is pinned to, or -1 if it isn't
 
 	void * init_data; 			// "shared" or "initial" data passed through launch, for setup
 
@@ -150,14 +354,9 @@ typedef struct pthreader_params {
 	pthreader_eval_fcn thread_eval; // evaluate function handle
 	pthreader_free_fcn thread_free;	// cleanup ("free") function handle
 	void * eval_params; 		// any parameters to pass through; MUST BE ASSIGNED IN SETUP FUNCTION CALL PROVIDED
-	void * eval_in; 			// data for evaluation, passed through evaluation
-	void * eval_out; 			// data for evaluation results, passed through evaluation
 
-	int * workflag;				// pointer to a flag indicating if there is work to do
-	int * statflag;				// pointer to a flag indicating evlauation status
-	pthread_mutex_t * worklock; // pointer to a worklock to ensure mutual exclusivity of workflag in shared memory
-	pthread_cond_t * cv_work; 	// pointer to a condition variable indicating work to do
-	pthread_cond_t * cv_free; 	// pointer to a condition variable indicating work done
+	pthreader_shared * shared;	// generation counter, countdown and job (epoch and tree dispatch)
+	struct pthreader_params ** peers; // every thread's control block, to find children (tree dispatch)
 
 	pthread_mutex_t * prntlock; // for verbose printing (have to ensure mutual exclusivity for sensible prints)
 
@@ -184,22 +383,27 @@ private:
 	int n_threads = 1;			// number of threads
 	int n_threads_minus_one;	// self-explanatory
 
+	pthreader_dispatch dispatch; // which engine evaluate() uses to hand out work
+
+	pthreader_placement placement = PTHREADER_PLACE_NONE; // how launch() pins threads to cpus
+	int * place_list = NULL;	// cpus for PTHREADER_PLACE_LIST
+	int n_place_list = 0;		// length of place_list
+#ifdef __linux__
+	cpu_set_t master_mask;		// the master's affinity before launch() pinned it, restored by close()
+#endif
+
+	long evaluations = 0;		// evaluations since the wait counters were last reset
+
 	// these are fixed and allocated at object construction
-	pthreader_params * thread_params; // n_threads length array of pthreader_params objects to pass to threads
+	pthreader_params ** thread_params; // n_threads length array of control blocks, one per thread (0 is this one)
+	pthreader_shared * shared; 	// what the epoch engine shares among all threads
 
 	// functions held here, too, for "master" thread evaluations
 	pthreader_setup_fcn thread_alloc; 	// setup ("allocate") function handle
 	pthreader_eval_fcn thread_eval; 	// evaluate function handle
 	pthreader_free_fcn thread_free; 	// cleanup ("free") function handle
 
-	void * eval_params; // any data to pass through; MUST BE ASSIGNED IN SETUP FUNCTION CALL PROVIDED
-
 	// these are only created with launch(), and destroyed with close()
-	int * workflag; 			// n_threads-1 length array to alert threads that work is available
-	int * statflag; 			// n_threads length array for evaluation status
-	pthread_mutex_t * worklock; // n_threads-1 length array of mutex locks for checking work
-	pthread_cond_t * cv_work; 	// n_threads-1 length array of condition variables for work to do
-	pthread_cond_t * cv_free; 	// n_threads-1 length array of condition variables for work done
 	pthread_t * thread; 		// n_threads-1 length array of actual thread objects
 
 	pthread_mutex_t prntlock; 	// for verbose
@@ -224,9 +428,29 @@ private:
 	int any_status_neg;
 #endif
 
+	void reset_status();			// reset accumulated status flags before an evaluation
+	void accumulate_status( int s ); // fold one thread's evaluation status into the accumulated flags
+	void accumulate_status_bits( int b ); // fold PTHREADER_STATUS_SEEN_* bits into the accumulated flags
+
+	void place();					// assign each thread a cpu (or -1) according to the placement
+	void spawn( int t , void * (*worker)( void * ) ); // create thread t running worker, pinned as placed
+
+	void launch_condvar( void * data ); // launch and evaluate with the condition variable engine
+	void evaluate_condvar( void * in , void * out );
+	void close_condvar();
+
+	void launch_epoch( void * data ); // launch and evaluate with the epoch engine
+	void evaluate_epoch( void * in , void * out );
+	void close_epoch();
+
+	void launch_tree( void * data ); // launch and evaluate with the tree engine
+	void evaluate_tree( void * in , void * out );
+	void close_tree();
+
 public:
 	
 	pthreader( int n_threads );		// constructor defining the number of threads
+	pthreader( int n_threads , pthreader_dispatch d ); // ... and the dispatch engine to use
 	~pthreader();					// destructor, kill threads (if needed) and clean up memory
 
 	void be_verbose();				// print out extra stuff during operation (to stdout)
@@ -236,6 +460,15 @@ public:
 	void set_evaluate( pthreader_eval_fcn f ); // define the evaluate function each thread will call
 	void set_cleanup( pthreader_free_fcn f ); // define the cleanup (free) function each thread will call
 
+	void set_wait_policy( pthreader_wait_policy w ); // how threads wait (PTHREADER_WAIT_BLOCK by default)
+	void set_wait_policy( pthreader_wait_policy w , int spins ); // ... bounding spins before sleeping
+	void get_wait_stats( int n , pthreader_wait_stats * s ); // thread n's wait counters (0 is the master)
+	void reset_wait_stats();		// zero every thread's wait counters
+
+	void set_placement( pthreader_placement p ); // how launch() pins threads (PTHREADER_PLACE_NONE by default)
+	void set_placement( const int * cpus , int n ); // pin thread t to cpus[t % n] (PTHREADER_PLACE_LIST)
+	int get_thread_cpu( int n );	// the cpu thread n is pinned to, or -1 if it isn't
+
 	int get_eval_status( int n ); 	// get the status flag from evaluations
 
 	int get_all_status_zero();		// convenience routine: were _all_ status' zero? 
@@ -1,5 +1,14 @@
 
 #include <stdexcept>
+#include <limits.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#else
+#include <sched.h>
+#endif
 
 #include "pthreader.h"
 
@@ -22,6 +31,191 @@ void * pthreader_setup_noop( int n , int N , void * data ) { return NULL; }
 int pthreader_eval_noop( int n , void * params , void * in , void * out ) { return 0; }
 void pthreader_close_noop( int n , void ** data ) {}
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * ATOMICS AND PARKING
+ * 
+ * used by the epoch and tree dispatch engines. Threads park on the shared counters themselves: on linux 
+ * that is a futex wait on the counter's address, elsewhere we just yield and check again. Before parking,
+ * a thread may spin for a while, depending on its wait policy.
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+static inline int pthreader_load( int * a ) { return __atomic_load_n( a , __ATOMIC_ACQUIRE ); }
+static inline void pthreader_store( int * a , int v ) { __atomic_store_n( a , v , __ATOMIC_RELEASE ); }
+
+// tell the cpu we are spinning
+static inline void pthreader_pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__( "yield" );
+#endif
+}
+
+// sleep while *a still holds v (may return spuriously, so always re-check)
+static inline void pthreader_futex_wait( int * a , int v )
+{
+#ifdef __linux__
+	syscall( SYS_futex , a , FUTEX_WAIT_PRIVATE , v , NULL , NULL , 0 );
+#else
+	sched_yield();
+#endif
+}
+
+// wake everybody sleeping on a
+static inline void pthreader_futex_wake( int * a )
+{
+#ifdef __linux__
+	syscall( SYS_futex , a , FUTEX_WAKE_PRIVATE , INT_MAX , NULL , NULL , 0 );
+#endif
+}
+
+// spin for a word to change from v, according to p's wait policy; returns 1 if it did (and 0 if the 
+// thread should go to sleep). Counts the spinning in p's wait counters.
+static inline int pthreader_spin( pthreader_params * p , int * a , int v )
+{
+	int i , w = __atomic_load_n( &(p->wait_policy) , __ATOMIC_RELAXED );
+	(p->wait_stats.waits)++;
+	if( w == PTHREADER_WAIT_BLOCK ) { return 0; }
+	for( i = 0 ; w == PTHREADER_WAIT_POLL || i < p->wait_spins ; i++ ) {
+		if( pthreader_load( a ) != v ) { p->wait_stats.spins += i; return 1; }
+		pthreader_pause();
+		if( ( i & 1023 ) == 1023 ) { w = __atomic_load_n( &(p->wait_policy) , __ATOMIC_RELAXED ); }
+	}
+	p->wait_stats.spins += i;
+	return 0;
+}
+
+// wait, on behalf of thread p, while w still holds v; returns the new value
+static inline int pthreader_wait( pthreader_params * p , pthreader_word * w , int v )
+{
+	int x;
+	if( ( x = pthreader_load( &(w->value) ) ) != v ) { return x; }
+	if( pthreader_spin( p , &(w->value) , v ) ) { return pthreader_load( &(w->value) ); }
+	// announce we are going to sleep before checking one last time, so a waker either sees us or we 
+	// see its store (both sides go through a full barrier)
+	__atomic_add_fetch( &(w->sleepers) , 1 , __ATOMIC_SEQ_CST );
+	while( ( x = pthreader_load( &(w->value) ) ) == v ) {
+		(p->wait_stats.parks)++;
+		pthreader_futex_wait( &(w->value) , v );
+	}
+	__atomic_sub_fetch( &(w->sleepers) , 1 , __ATOMIC_SEQ_CST );
+	return x;
+}
+
+// set w, waking anybody asleep on it
+static inline void pthreader_post( pthreader_word * w , int v )
+{
+	__atomic_store_n( &(w->value) , v , __ATOMIC_SEQ_CST );
+	if( __atomic_load_n( &(w->sleepers) , __ATOMIC_SEQ_CST ) > 0 ) { pthreader_futex_wake( &(w->value) ); }
+}
+
+// count down one thread, waking the waiter if we were the last one
+static inline void pthreader_arrive( pthreader_word * pending )
+{
+	if( __atomic_sub_fetch( &(pending->value) , 1 , __ATOMIC_SEQ_CST ) == 0 ) {
+		if( __atomic_load_n( &(pending->sleepers) , __ATOMIC_SEQ_CST ) > 0 ) { pthreader_futex_wake( &(pending->value) ); }
+	}
+}
+
+// wait, on behalf of thread p, until every thread has counted down
+static inline void pthreader_await( pthreader_params * p , pthreader_word * pending )
+{
+	int x = pthreader_load( &(pending->value) );
+	while( x != 0 ) { x = pthreader_wait( p , pending , x ); }
+}
+
+// the PTHREADER_STATUS_SEEN_* bit for one evaluation status
+static inline int pthreader_status_bit( int s )
+{
+	return ( s == 0 ? PTHREADER_STATUS_SEEN_ZERO : ( s > 0 ? PTHREADER_STATUS_SEEN_POS : PTHREADER_STATUS_SEEN_NEG ) );
+}
+
+// tree engine: open generation g for each of thread t's children
+static inline void pthreader_tree_wake( pthreader_params ** peers , int t , int n , int g )
+{
+	int c , last = PTHREADER_TREE_FANOUT * t + PTHREADER_TREE_FANOUT;
+	for( c = PTHREADER_TREE_FANOUT * t + 1 ; c <= last && c < n ; c++ ) {
+		pthreader_post( &(peers[c]->gen) , g );
+	}
+}
+
+// tree engine: wait for each of thread t's children to finish generation g, returning their status bits
+static inline int pthreader_tree_join( pthreader_params ** peers , int t , int n , int g )
+{
+	int c , d , bits = 0 , last = PTHREADER_TREE_FANOUT * t + PTHREADER_TREE_FANOUT;
+	for( c = PTHREADER_TREE_FANOUT * t + 1 ; c <= last && c < n ; c++ ) {
+		d = pthreader_load( &(peers[c]->done.value) );
+		while( d != g ) { d = pthreader_wait( peers[t] , &(peers[c]->done) , d ); }
+		bits |= peers[c]->bits;
+	}
+	return bits;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * CONTROL BLOCK MEMORY
+ * 
+ * every thread's control block gets whole pages of its own, which the thread then moves to its own NUMA 
+ * node (we don't want to depend on libnuma, so this goes straight to the move_pages system call).
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#define PTHREADER_MPOL_MF_MOVE (1<<1) // from numaif.h
+
+static size_t pthreader_page_size()
+{
+	long page = sysconf( _SC_PAGESIZE );
+	return ( page > 0 ? (size_t)page : 4096 );
+}
+
+// round size up to whole pages
+static size_t pthreader_page_round( size_t size )
+{
+	size_t page = pthreader_page_size();
+	return ( ( size + page - 1 ) / page ) * page;
+}
+
+// page-aligned allocation of whole pages (free with free)
+static void * pthreader_page_alloc( size_t size )
+{
+	void * p = NULL;
+	if( posix_memalign( &p , pthreader_page_size() , pthreader_page_round( size ) ) != 0 ) { return NULL; }
+	return p;
+}
+
+// move the pages holding [p,p+size) to the NUMA node of the cpu the calling thread is running on. This is
+// a hint: if there is only one node, or the system call is unavailable or refused, nothing happens.
+static void pthreader_localize( void * p , size_t size )
+{
+#if defined(__linux__) && defined(SYS_move_pages) && defined(SYS_getcpu)
+	unsigned int cpu , node;
+	size_t page = pthreader_page_size() , n , i;
+	void * pages[64];
+	int nodes[64] , status[64];
+
+	if( syscall( SYS_getcpu , &cpu , &node , NULL ) != 0 ) { return; }
+
+	n = pthreader_page_round( size ) / page;
+	if( n > 64 ) { n = 64; }
+	for( i = 0 ; i < n ; i++ ) {
+		pages[i] = (void*)( (char*)p + i * page );
+		nodes[i] = (int)node;
+	}
+	syscall( SYS_move_pages , 0 , (unsigned long)n , pages , nodes , status , PTHREADER_MPOL_MF_MOVE );
+#endif
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -40,9 +234,11 @@ void pthreader_close_noop( int n , void ** data ) {}
 // 
 void * threaded_worker( void * arg ) 
 {
-	int i;
 	pthreader_params * params = ( pthreader_params * )arg; // thread id included
 
+	// bring our control block to our own node before we start using it
+	pthreader_localize( params , sizeof( pthreader_params ) );
+
 	if( params->prnt && ( params->prntlock != NULL ) ) {
 		pthread_mutex_lock( params->prntlock );
 		printf( "launching thread %i / %i\n" , params->thrd + 1 , params->nthd ); fflush( stdout );
@@ -54,21 +250,24 @@ void * threaded_worker( void * arg )
 	params->eval_params = ( params->thread_alloc )( params->thrd , params->nthd , params->init_data ); 
 
 	// signal we are done with setup using cv_free condition variable
-	// passed parameter structure says which lock this thread should use
-	pthread_mutex_lock( params->worklock );
-	(params->workflag)[0] = 0;
-	pthread_cond_signal( params->cv_free );
-	pthread_mutex_unlock( params->worklock );
+	pthread_mutex_lock( &(params->worklock) );
+	pthreader_store( &(params->work) , 0 );
+	pthread_cond_signal( &(params->cv_free) );
+	pthread_mutex_unlock( &(params->worklock) );
 
 	// work loop, waiting for signals that work is ready to do or that we're done
 	while( 1 ) {
 
-		// ensure mutual exclusivity of shared memory to check workflag
-		pthread_mutex_lock( params->worklock );
+		// spin for work first, if our wait policy says to, so we may not have to sleep
+		if( pthreader_load( &(params->work) ) == 0 ) { pthreader_spin( params , &(params->work) , 0 ); }
 
-		// if workflag isn't set, wait until it is
-		if( (params->workflag)[0] == 0 ) { 
-			pthread_cond_wait( params->cv_work , params->worklock );
+		// ensure mutual exclusivity of shared memory to check work
+		pthread_mutex_lock( &(params->worklock) );
+
+		// if work isn't set, wait until it is
+		while( params->work == 0 ) {
+			(params->wait_stats.parks)++;
+			pthread_cond_wait( &(params->cv_work) , &(params->worklock) );
 			// (implicitly unlocks and, when done blocking, re-locks)
 		}
 
@@ -79,19 +278,113 @@ void * threaded_worker( void * arg )
 			if( params->thread_free != NULL ) {
 				(params->thread_free)( params->thrd , &(params->eval_params) ); 
 			}
+			pthread_mutex_unlock( &(params->worklock) );
 			pthread_exit( NULL ); // kill the thread
 			return NULL;
 		}
 
 		// otherwise, do work
-		(params->statflag)[0] = (params->thread_eval)( params->thrd , params->eval_params , params->eval_in , params->eval_out );
+		params->status = (params->thread_eval)( params->thrd , params->eval_params , params->eval_in , params->eval_out );
 
 		// signal that we are done
-		(params->workflag)[0] = 0; // clear workflag because work is done
-		pthread_cond_signal( params->cv_free ); // signal that work is done
+		pthreader_store( &(params->work) , 0 ); // clear work because work is done
+		pthread_cond_signal( &(params->cv_free) ); // signal that work is done
 
 		// we're done with mutual exclusivity
-		pthread_mutex_unlock( params->worklock );
+		pthread_mutex_unlock( &(params->worklock) );
+
+	}
+
+	return NULL;
+}
+
+// the same contract as threaded_worker, but driven by the epoch engine: wait for the shared generation 
+// counter to move past the last one we saw, run the published job, and count down
+void * threaded_worker_epoch( void * arg ) 
+{
+	int seen = 0 , e;
+	pthreader_params * params = ( pthreader_params * )arg; // thread id included
+	pthreader_shared * shared = params->shared;
+	pthreader_job * job = &(shared->job);
+
+	pthreader_localize( params , sizeof( pthreader_params ) );
+
+	if( params->prnt && ( params->prntlock != NULL ) ) {
+		pthread_mutex_lock( params->prntlock );
+		printf( "launching thread %i / %i\n" , params->thrd + 1 , params->nthd ); fflush( stdout );
+		pthread_mutex_unlock( params->prntlock );
+	}
+
+	// setup is generation zero
+	params->eval_params = ( params->thread_alloc )( params->thrd , params->nthd , params->init_data ); 
+	pthreader_arrive( &(shared->pending) );
+
+	while( 1 ) {
+
+		// wait for the master to open a new generation. The master never opens one before 
+		// everybody has counted down from the last, so we can't skip a generation.
+		e = pthreader_wait( params , &(shared->epoch) , seen );
+		seen = e;
+
+		if( job->exit ) {
+			if( params->thread_free != NULL ) {
+				(params->thread_free)( params->thrd , &(params->eval_params) ); 
+			}
+			return NULL;
+		}
+
+		params->status = (job->thread_eval)( params->thrd , params->eval_params , job->eval_in , job->eval_out );
+
+		pthreader_arrive( &(shared->pending) );
+
+	}
+
+	return NULL;
+}
+
+// the same contract again, driven by the tree engine: wait for our parent to open a generation, open it 
+// for our children, evaluate, and report to our parent only once our children have reported to us
+void * threaded_worker_tree( void * arg )
+{
+	int seen = 0 , g , bits;
+	pthreader_params * params = ( pthreader_params * )arg; // thread id included
+	pthreader_shared * shared = params->shared;
+	pthreader_job * job = &(shared->job);
+
+	pthreader_localize( params , sizeof( pthreader_params ) );
+
+	if( params->prnt && ( params->prntlock != NULL ) ) {
+		pthread_mutex_lock( params->prntlock );
+		printf( "launching thread %i / %i\n" , params->thrd + 1 , params->nthd ); fflush( stdout );
+		pthread_mutex_unlock( params->prntlock );
+	}
+
+	// setup doesn't need the tree, just a countdown
+	params->eval_params = ( params->thread_alloc )( params->thrd , params->nthd , params->init_data );
+	pthreader_arrive( &(shared->pending) );
+
+	while( 1 ) {
+
+		g = pthreader_wait( params , &(params->gen) , seen );
+		seen = g;
+
+		// pass the generation on first, so our children start as soon as possible
+		pthreader_tree_wake( params->peers , params->thrd , params->nthd , g );
+
+		if( job->exit ) {
+			if( params->thread_free != NULL ) {
+				(params->thread_free)( params->thrd , &(params->eval_params) );
+			}
+			return NULL;
+		}
+
+		params->status = (job->thread_eval)( params->thrd , params->eval_params , job->eval_in , job->eval_out );
+
+		bits  = pthreader_status_bit( params->status );
+		bits |= pthreader_tree_join( params->peers , params->thrd , params->nthd , g );
+
+		params->bits = bits;
+		pthreader_post( &(params->done) , g );
 
 	}
 
@@ -110,7 +403,9 @@ void * threaded_worker( void * arg )
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
-pthreader::pthreader( int n ) : n_threads(n)
+pthreader::pthreader( int n ) : pthreader( n , PTHREADER_DISPATCH_CONDVAR ) {}
+
+pthreader::pthreader( int n , pthreader_dispatch d ) : n_threads(n) , dispatch(d)
 {
 	int t;
 
@@ -124,42 +419,69 @@ pthreader::pthreader( int n ) : n_threads(n)
 		throw invalid_argument( "Number of threads must be two or more." );
 	}
 
+	if( dispatch != PTHREADER_DISPATCH_CONDVAR && dispatch != PTHREADER_DISPATCH_EPOCH && dispatch != PTHREADER_DISPATCH_TREE ) {
+		throw invalid_argument( "Unknown dispatch engine." );
+	}
+
 	// we use this a bunch, so might as well just define it
 	n_threads_minus_one = n_threads - 1;
 
 	thread_alloc = pthreader_setup_noop;
 	thread_eval  = pthreader_eval_noop;
 	thread_free  = pthreader_close_noop;
-	eval_params  = NULL;
 
-	// allocate space for the thread parameter objects
-	thread_params = ( pthreader_params * )malloc( n_threads_minus_one * sizeof( pthreader_params ) );
+	// the epoch engine's shared counters
+	if( posix_memalign( (void**)(&shared) , PTHREADER_CACHE_LINE , sizeof( pthreader_shared ) ) != 0 ) {
+		throw bad_alloc();
+	}
+	shared->epoch.value   = 0;
+	shared->epoch.sleepers   = 0;
+	shared->pending.value = 0;
+	shared->pending.sleepers = 0;
+
+	// allocate space for the thread control blocks, each on pages of its own
+	thread_params = ( pthreader_params ** )malloc( n_threads * sizeof( pthreader_params * ) );
 
 	// initialize those objects
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
+	for( t = 0 ; t < n_threads ; t++ ) {
+
+		thread_params[t] = ( pthreader_params * )pthreader_page_alloc( sizeof( pthreader_params ) );
+		if( thread_params[t] == NULL ) { throw bad_alloc(); }
+
+		thread_params[t]->work   = 0;
+		thread_params[t]->status = 0;
+		thread_params[t]->gen.value     = 0;
+		thread_params[t]->gen.sleepers  = 0;
+		thread_params[t]->done.value    = 0;
+		thread_params[t]->done.sleepers = 0;
+		thread_params[t]->bits   = 0;
 
-		thread_params[t].exit = 0; // don't exit
-		thread_params[t].thrd = t+1; // the thread number (increment because this is running in thread "0")
-		thread_params[t].nthd = n_threads; // total number of threads
-		thread_params[t].prnt = verbose; // be verbose? (DEFAULT IS NO)
+		thread_params[t]->wait_policy = PTHREADER_WAIT_BLOCK;
+		thread_params[t]->wait_spins  = PTHREADER_WAIT_SPINS;
+		thread_params[t]->wait_stats.evaluations = 0;
+		thread_params[t]->wait_stats.waits = 0;
+		thread_params[t]->wait_stats.spins = 0;
+		thread_params[t]->wait_stats.parks = 0;
 
-		thread_params[t].init_data 		= NULL; // default
+		thread_params[t]->exit = 0; // don't exit
+		thread_params[t]->thrd = t; // the thread number ("0" is this one)
+		thread_params[t]->nthd = n_threads; // total number of threads
+		thread_params[t]->prnt = verbose; // be verbose? (DEFAULT IS NO)
 
-		thread_params[t].thread_alloc 	= pthreader_setup_noop;
-		thread_params[t].thread_eval  	= pthreader_eval_noop;
-		thread_params[t].thread_free  	= pthreader_close_noop;
+		thread_params[t]->init_data 	= NULL; // default
 
-		thread_params[t].eval_params  	= NULL; // default
-		thread_params[t].eval_in 	  	= NULL; // default
-		thread_params[t].eval_out 	  	= NULL; // default
+		thread_params[t]->thread_alloc 	= pthreader_setup_noop;
+		thread_params[t]->thread_eval  	= pthreader_eval_noop;
+		thread_params[t]->thread_free  	= pthreader_close_noop;
 
-		thread_params[t].workflag 		= NULL;
-		thread_params[t].statflag 		= NULL;
-		thread_params[t].worklock 		= NULL;
-		thread_params[t].cv_work  		= NULL;
-		thread_params[t].cv_free  		= NULL;
+		thread_params[t]->eval_params  	= NULL; // default
+		thread_params[t]->eval_in 	  	= NULL; // default
+		thread_params[t]->eval_out 	  	= NULL; // default
 
-		thread_params[t].prntlock 		= NULL;
+		thread_params[t]->shared 		= shared;
+		thread_params[t]->peers 		= thread_params;
+
+		thread_params[t]->prntlock 		= NULL;
 
 	}
 
@@ -169,9 +491,12 @@ pthreader::pthreader( int n ) : n_threads(n)
 
 pthreader::~pthreader( )
 {
+	int t;
 	if( threads_open ) { close(); }
 	if( verbose ) { pthread_mutex_destroy( &prntlock ); }
+	for( t = 0 ; t < n_threads ; t++ ) { free( thread_params[t] ); }
 	free( thread_params );
+	free( shared );
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -190,9 +515,9 @@ void pthreader::be_verbose()
 	if( verbose ) { return; } // ignore if we are verbose already
 	verbose = 1; 
 	pthread_mutex_init( &prntlock , NULL );
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) { 
-		thread_params[t].prnt = verbose; 
-		thread_params[t].prntlock = &prntlock; 
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->prnt = verbose;
+		thread_params[t]->prntlock = &prntlock;
 	}
 }
 
@@ -202,9 +527,9 @@ void pthreader::be_quiet()
 	if( ! verbose ) { return; } // ignore if we are quiet already
 	verbose = 0; 
 	pthread_mutex_destroy( &prntlock );
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) { 
-		thread_params[t].prnt = verbose; 
-		thread_params[t].prntlock = NULL; 
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->prnt = verbose;
+		thread_params[t]->prntlock = NULL;
 	}
 }
 
@@ -224,8 +549,8 @@ void pthreader::set_setup( pthreader_setup_fcn f )
 {
 	int t;
 	thread_alloc = f; // store in this object's data
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
-		thread_params[t].thread_alloc = f; // store in thread data
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->thread_alloc = f; // store in thread data
 	}
 }
 
@@ -233,8 +558,8 @@ void pthreader::set_evaluate( pthreader_eval_fcn f )
 {
 	int t;
 	thread_eval = f; // store in this object's data
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
-		thread_params[t].thread_eval = f; // store in thread data
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->thread_eval = f; // store in thread data
 	}
 }
 
@@ -242,8 +567,54 @@ void pthreader::set_cleanup( pthreader_free_fcn f )
 {
 	int t;
 	thread_free = f; // store in this object's data
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
-		thread_params[t].thread_free = f; // store in thread data
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->thread_free = f; // store in thread data
+	}
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * WAIT POLICY
+ * 
+ * how threads wait, and how much they have had to
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void pthreader::set_wait_policy( pthreader_wait_policy w ) { set_wait_policy( w , PTHREADER_WAIT_SPINS ); }
+
+void pthreader::set_wait_policy( pthreader_wait_policy w , int spins )
+{
+	int t;
+	if( w != PTHREADER_WAIT_BLOCK && w != PTHREADER_WAIT_SPIN && w != PTHREADER_WAIT_POLL ) {
+		if( verbose ) { printf( "Unknown wait policy, ignoring it.\n" ); }
+		return;
+	}
+	// threads read these as they go, so it is safe (if not exactly synchronized) to change them while running
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->wait_spins = ( spins > 0 ? spins : 0 );
+		__atomic_store_n( &(thread_params[t]->wait_policy) , (int)w , __ATOMIC_RELAXED );
+	}
+}
+
+void pthreader::get_wait_stats( int n , pthreader_wait_stats * s )
+{
+	if( n < 0 || n >= n_threads || s == NULL ) { return; }
+	s[0] = thread_params[n]->wait_stats;
+	s->evaluations = evaluations;
+}
+
+void pthreader::reset_wait_stats()
+{
+	int t;
+	evaluations = 0;
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->wait_stats.waits = 0;
+		thread_params[t]->wait_stats.spins = 0;
+		thread_params[t]->wait_stats.parks = 0;
 	}
 }
 
@@ -261,88 +632,148 @@ void pthreader::set_cleanup( pthreader_free_fcn f )
 
 int pthreader::get_eval_status( int n )
 {
-	if( threads_open ) { return statflag[n]; }
+	if( threads_open ) { return thread_params[n]->status; }
 	else { return 0; }
 }
 
 int pthreader::get_all_status_zero() 
-{ 
+{
 #ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_ZERO
 	return all_status_zero; 
 #else
 	int flag = 1;
 	for( int t = 0 ; t < n_threads ; t++ ) {
-		if( statflag[t] != 0 ) { return 0; }
+		if( thread_params[t]->status != 0 ) { return 0; }
 	}
 	return flag;
 #endif
 }
 
 int pthreader::get_all_status_positive() 
-{ 
+{
 #ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_POS
 	return all_status_pos; 
 #else
 	int flag = 1;
 	for( int t = 0 ; t < n_threads ; t++ ) {
-		if( statflag[t] <= 0 ) { return 0; }
+		if( thread_params[t]->status <= 0 ) { return 0; }
 	}
 	return flag;
 #endif
 }
 
 int pthreader::get_all_status_negative() 
-{ 
+{
 #ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_NEG
 	return all_status_neg; 
 #else
 	int flag = 1;
 	for( int t = 0 ; t < n_threads ; t++ ) {
-		if( statflag[t] >= 0 ) { return 0; }
+		if( thread_params[t]->status >= 0 ) { return 0; }
 	}
 	return flag;
 #endif
 }
 
 int pthreader::get_any_status_zero() 
-{ 
+{
 #ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_ZERO
-	return any_status_pos; 
+	return any_status_zero; 
 #else
 	int flag = 0;
 	for( int t = 0 ; t < n_threads ; t++ ) {
-		if( statflag[t] == 0 ) { return 1; }
+		if( thread_params[t]->status == 0 ) { return 1; }
 	}
 	return flag;
 #endif
 }
 
 int pthreader::get_any_status_positive() 
-{ 
+{
 #ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_POS
 	return any_status_pos; 
 #else
 	int flag = 0;
 	for( int t = 0 ; t < n_threads ; t++ ) {
-		if( statflag[t] > 0 ) { return 1; }
+		if( thread_params[t]->status > 0 ) { return 1; }
 	}
 	return flag;
 #endif
 }
 
 int pthreader::get_any_status_negative() 
-{ 
+{
 #ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_NEG
 	return any_status_neg; 
 #else
 	int flag = 0;
 	for( int t = 0 ; t < n_threads ; t++ ) {
-		if( statflag[t] < 0 ) { return 1; }
+		if( thread_params[t]->status < 0 ) { return 1; }
 	}
 	return flag;
 #endif
 }
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * STATUS ACCUMULATION
+ * 
+ * shared by all the dispatch engines
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+void pthreader::reset_status()
+{
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_ZERO
+	all_status_zero = 1;
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_POS
+	all_status_pos  = 1;
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_NEG
+	all_status_neg  = 1;
+#endif
+
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_ZERO
+	any_status_zero = 0;
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_POS
+	any_status_pos  = 0;
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_NEG
+	any_status_neg  = 0;
+#endif
+}
+
+void pthreader::accumulate_status( int s ) { accumulate_status_bits( pthreader_status_bit( s ) ); }
+
+void pthreader::accumulate_status_bits( int b )
+{
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_ZERO
+	all_status_zero = ( b & ( PTHREADER_STATUS_SEEN_POS  | PTHREADER_STATUS_SEEN_NEG ) ? 0 : all_status_zero );
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_POS
+	all_status_pos  = ( b & ( PTHREADER_STATUS_SEEN_ZERO | PTHREADER_STATUS_SEEN_NEG ) ? 0 : all_status_pos  );
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_NEG
+	all_status_neg  = ( b & ( PTHREADER_STATUS_SEEN_ZERO | PTHREADER_STATUS_SEEN_POS ) ? 0 : all_status_neg  );
+#endif
+
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_ZERO
+	any_status_zero = ( b & PTHREADER_STATUS_SEEN_ZERO ? 1 : any_status_zero );
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_POS
+	any_status_pos  = ( b & PTHREADER_STATUS_SEEN_POS  ? 1 : any_status_pos  );
+#endif
+#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_NEG
+	any_status_neg  = ( b & PTHREADER_STATUS_SEEN_NEG  ? 1 : any_status_neg  );
+#endif
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -368,59 +799,61 @@ void pthreader::launch( void * data )
 		return;
 	}
 
-	if( verbose ) { 
+	if( verbose ) {
 		pthread_mutex_lock( &prntlock );
 		printf( "launching %i threads...\n" , n_threads );
 		pthread_mutex_unlock( &prntlock );
 	}
 
-	// actually allocate the workflag list
-	workflag = ( int * )malloc( n_threads_minus_one * sizeof(int) );
+	// allocate the thread objects
+	thread = ( pthread_t * )malloc( n_threads_minus_one * sizeof( pthread_t ) );
 
-	// allocate status flags (for all threads, including this central one)
-	statflag = ( int * )malloc( n_threads * sizeof(int) );
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->status    = 0;
+		thread_params[t]->init_data = data;
+	}
 
-	// allocate the mutexes, condition variables, and thread data structures
-	worklock = ( pthread_mutex_t * )malloc( n_threads_minus_one * sizeof( pthread_mutex_t ) );
-	cv_work  = ( pthread_cond_t  * )malloc( n_threads_minus_one * sizeof( pthread_cond_t  ) );
-	cv_free  = ( pthread_cond_t  * )malloc( n_threads_minus_one * sizeof( pthread_cond_t  ) );
-	thread 	 = ( pthread_t       * )malloc( n_threads_minus_one * sizeof( pthread_t       ) );
+	switch( dispatch ) {
+		case PTHREADER_DISPATCH_EPOCH : launch_epoch( data ); break;
+		case PTHREADER_DISPATCH_TREE  : launch_tree( data ); break;
+		default : launch_condvar( data ); break;
+	}
+
+	// set the running flag
+	threads_open = 1;
+
+}
+
+void pthreader::launch_condvar( void * data )
+{
+	int t;
 
 	// for each thread we spawn, create a thread and call the generic "worker" routine
 	// this will, on launch, execute any setup routines specified
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
+	for( t = 1 ; t < n_threads ; t++ ) {
 
 		// initialize the pthread construct parts
-		workflag[t] = 1; // start ** with ** work when we run setup
-		pthread_mutex_init( worklock + t , NULL );
-		pthread_cond_init( cv_work + t , NULL );
-		pthread_cond_init( cv_free + t , NULL );
-
-		// set the right pointers in the thread_params objects
-		thread_params[t].workflag  = workflag + t;
-		thread_params[t].statflag  = statflag + t + 1; // increment by one here, as we store all of them
-
-		thread_params[t].worklock  = worklock + t;
-		thread_params[t].cv_work   = cv_work  + t;
-		thread_params[t].cv_free   = cv_free  + t;
-		thread_params[t].init_data = data;
+		pthreader_store( &(thread_params[t]->work) , 1 ); // start ** with ** work when we run setup
+		pthread_mutex_init( &(thread_params[t]->worklock) , NULL );
+		pthread_cond_init( &(thread_params[t]->cv_work) , NULL );
+		pthread_cond_init( &(thread_params[t]->cv_free) , NULL );
 
 		// actually create the threads... this should define eval_params in each thread
-		pthread_create( thread + t , NULL , threaded_worker , (void*)( thread_params + t ) );
+		pthread_create( thread + t - 1 , NULL , threaded_worker , (void*)( thread_params[t] ) );
 
 	}
 
 	// we do this ourselves, here, too but don't need to set the pointers
 
 	// print if we should... 
-	if( verbose ) { 
+	if( verbose ) {
 		pthread_mutex_lock( &prntlock );
 		printf( "launching thread %i / %i\n" , 1 , n_threads );
 		pthread_mutex_unlock( &prntlock );
 	}
 
 	// do setup, assigning the data pointer in the parameter object passed in...
-	eval_params = thread_alloc( 0 , n_threads , data );
+	thread_params[0]->eval_params = thread_alloc( 0 , n_threads , data );
 
 	// print if we want
 	if( verbose ) {
@@ -430,21 +863,107 @@ void pthreader::launch( void * data )
 	}
 
 	// wait until thread setup _completes_
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
-		pthread_mutex_lock( worklock + t );
-		if( workflag[t] == 1 ) { // if thread t is still working...
-			pthread_cond_wait( cv_free + t , worklock + t ); // wait for it to signal done
+	for( t = 1 ; t < n_threads ; t++ ) {
+		pthread_mutex_lock( &(thread_params[t]->worklock) );
+		while( thread_params[t]->work == 1 ) { // if thread t is still working...
+			pthread_cond_wait( &(thread_params[t]->cv_free) , &(thread_params[t]->worklock) ); // wait for it to signal done
 		}
 		if( verbose ) {
 			pthread_mutex_lock( &prntlock );
-			printf( "thread %i is done setting up.\n" , t+2 );
+			printf( "thread %i is done setting up.\n" , t+1 );
 			pthread_mutex_unlock( &prntlock );
 		}
-		pthread_mutex_unlock( worklock + t );
+		pthread_mutex_unlock( &(thread_params[t]->worklock) );
 	}
 
-	// set the running flag
-	threads_open = 1;
+}
+
+void pthreader::launch_epoch( void * data )
+{
+	int t;
+
+	// generation zero is "setup"; every spawned thread counts down once it has run setup
+	shared->epoch.value   = 0;
+	shared->pending.value = n_threads_minus_one;
+
+	shared->job.exit = 0;
+	shared->job.thread_eval = thread_eval;
+	shared->job.eval_in  = NULL;
+	shared->job.eval_out = NULL;
+
+	for( t = 1 ; t < n_threads ; t++ ) {
+		pthread_create( thread + t - 1 , NULL , threaded_worker_epoch , (void*)( thread_params[t] ) );
+	}
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "launching thread %i / %i\n" , 1 , n_threads );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+	thread_params[0]->eval_params = thread_alloc( 0 , n_threads , data );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "thread %i is done setting up.\n" , 1 );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+	// wait until every thread has counted down from setup
+	pthreader_await( thread_params[0] , &(shared->pending) );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "threads %i through %i are done setting up.\n" , 2 , n_threads );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+}
+
+void pthreader::launch_tree( void * data )
+{
+	int t;
+
+	// setup is counted down just like the epoch engine; the tree is only used for evaluations
+	shared->epoch.value   = 0;
+	shared->pending.value = n_threads_minus_one;
+
+	shared->job.exit = 0;
+	shared->job.thread_eval = thread_eval;
+	shared->job.eval_in  = NULL;
+	shared->job.eval_out = NULL;
+
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->gen.value  = 0;
+		thread_params[t]->done.value = 0;
+		thread_params[t]->bits = 0;
+	}
+
+	for( t = 1 ; t < n_threads ; t++ ) {
+		pthread_create( thread + t - 1 , NULL , threaded_worker_tree , (void*)( thread_params[t] ) );
+	}
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "launching thread %i / %i\n" , 1 , n_threads );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+	thread_params[0]->eval_params = thread_alloc( 0 , n_threads , data );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "thread %i is done setting up.\n" , 1 );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+	pthreader_await( thread_params[0] , &(shared->pending) );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "threads %i through %i are done setting up.\n" , 2 , n_threads );
+		pthread_mutex_unlock( &prntlock );
+	}
 
 }
 
@@ -462,8 +981,6 @@ void pthreader::launch( void * data )
 
 void pthreader::evaluate( void * in , void * out )
 {
-	int t;
-
 	if( ! threads_open ) {
 		if( verbose ) {
 			printf( "You have not launched any threads to evaluate over.\n" );
@@ -471,63 +988,41 @@ void pthreader::evaluate( void * in , void * out )
 		return;
 	}
 
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_ZERO
-	all_status_zero = 1;
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_POS
-	all_status_pos  = 1;
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_NEG
-	all_status_neg  = 1;
-#endif
-	
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_ZERO
-	any_status_zero = 0;
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_POS
-	any_status_pos  = 0;
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_NEG
-	any_status_neg  = 0;
-#endif
+	reset_status();
+	evaluations++;
+
+	switch( dispatch ) {
+		case PTHREADER_DISPATCH_EPOCH : evaluate_epoch( in , out ); break;
+		case PTHREADER_DISPATCH_TREE  : evaluate_tree( in , out ); break;
+		default : evaluate_condvar( in , out ); break;
+	}
+}
+
+void pthreader::evaluate_condvar( void * in , void * out )
+{
+	int t;
+	pthreader_params * p;
 
 	// loop through worker threads storing data object and signaling that work is available
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) { 
-		pthread_mutex_lock( worklock + t );
-		if( workflag[t] == 1 ) {
+	for( t = 1 ; t < n_threads ; t++ ) {
+		p = thread_params[t];
+		pthread_mutex_lock( &(p->worklock) );
+		while( p->work == 1 ) {
 			// wait for this thread to get free... but it should be free already...
 			// note this call implicitly unlocks and, when ready, relocks the mutex
-			pthread_cond_wait( cv_free + t , worklock + t ); 
+			pthread_cond_wait( &(p->cv_free) , &(p->worklock) );
 		}
-		thread_params[t].eval_in  = in;  // store passed data object now that it is safe
-		thread_params[t].eval_out = out; // store passed data object now that it is safe
-		workflag[t] = 1; // set shared memory flag to one to declare work
-		pthread_cond_signal( cv_work + t ); // signal work is available
-		pthread_mutex_unlock( worklock + t ); // unlock the mutex for this thread
+		p->eval_in  = in;  // store passed data object now that it is safe
+		p->eval_out = out; // store passed data object now that it is safe
+		pthreader_store( &(p->work) , 1 ); // set shared memory flag to one to declare work
+		pthread_cond_signal( &(p->cv_work) ); // signal work is available
+		pthread_mutex_unlock( &(p->worklock) ); // unlock the mutex for this thread
 	}
 
 	// do work here, in this thread, too... using params constructed with setup fcn
-	statflag[0] = thread_eval( 0 , eval_params , in , out );
-
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_ZERO
-	all_status_zero = ( statflag[0] == 0 ? all_status_zero : 0 );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_POS
-	all_status_pos  = ( statflag[0]  > 0 ? all_status_pos  : 0 );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_NEG
-	all_status_neg  = ( statflag[0]  < 0 ? all_status_neg  : 0 );
-#endif
-
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_ZERO
-	any_status_zero = ( statflag[0] == 0 ? 1 : any_status_zero );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_POS
-	any_status_pos  = ( statflag[0]  > 0 ? 1 : any_status_pos  );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_NEG
-	any_status_neg  = ( statflag[0]  < 0 ? 1 : any_status_neg  );
-#endif
+	p = thread_params[0];
+	p->status = thread_eval( 0 , p->eval_params , in , out );
+	accumulate_status( p->status );
 
 	if( verbose ) {
 		pthread_mutex_lock( &prntlock );
@@ -536,44 +1031,101 @@ void pthreader::evaluate( void * in , void * out )
 	}
 
 	// wait until evaluations complete
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
+	for( t = 1 ; t < n_threads ; t++ ) {
 
-		pthread_mutex_lock( worklock + t );
-		if( workflag[t] == 1 ) { // if thread t is still working...
-			pthread_cond_wait( cv_free + t , worklock + t ); // wait for it to signal done
-		}
+		p = thread_params[t];
 
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_ZERO
-		all_status_zero = ( statflag[t+1] == 0 ? all_status_zero : 0 );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_POS
-		all_status_pos  = ( statflag[t+1]  > 0 ? all_status_pos : 0 );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ALL_NEG
-		all_status_neg  = ( statflag[t+1]  < 0 ? all_status_neg : 0 );
-#endif
+		// spin for it first, if our wait policy says to
+		if( pthreader_load( &(p->work) ) == 1 ) { pthreader_spin( thread_params[0] , &(p->work) , 1 ); }
 
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_ZERO
-		any_status_zero = ( statflag[t+1] == 0 ? 1 : any_status_zero );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_POS
-		any_status_pos  = ( statflag[t+1] >  0 ? 1 : any_status_pos );
-#endif
-#ifdef _PTHREADER_COMPILE_ACCUM_EVAL_STATUS_ANY_NEG
-		any_status_neg  = ( statflag[t+1] <  0 ? 1 : any_status_neg );
-#endif
+		pthread_mutex_lock( &(p->worklock) );
+		while( p->work == 1 ) { // if thread t is still working...
+			(thread_params[0]->wait_stats.parks)++;
+			pthread_cond_wait( &(p->cv_free) , &(p->worklock) ); // wait for it to signal done
+		}
+
+		accumulate_status( p->status );
 
 		if( verbose ) {
 			pthread_mutex_lock( &prntlock );
-			printf( "thread %i knows thread %i is done evaluating.\n" , 1 , t+2 );
+			printf( "thread %i knows thread %i is done evaluating.\n" , 1 , t+1 );
 			pthread_mutex_unlock( &prntlock );
 		}
 
-		pthread_mutex_unlock( worklock + t );
+		pthread_mutex_unlock( &(p->worklock) );
 
 	}
 }
 
+void pthreader::evaluate_epoch( void * in , void * out )
+{
+	int t;
+	pthreader_params * p;
+
+	// publish the job, arm the countdown, and only then open the new generation; the release
+	// store on epoch makes the job visible to any thread that sees the new generation
+	shared->job.thread_eval = thread_eval;
+	shared->job.eval_in  = in;
+	shared->job.eval_out = out;
+	shared->pending.value = n_threads_minus_one;
+	pthreader_post( &(shared->epoch) , shared->epoch.value + 1 );
+
+	// do work here, in this thread, too
+	p = thread_params[0];
+	p->status = thread_eval( 0 , p->eval_params , in , out );
+	accumulate_status( p->status );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "thread %i is done evaluating.\n" , 1 );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+	// one wait for everybody, instead of one per thread
+	pthreader_await( thread_params[0] , &(shared->pending) );
+
+	for( t = 1 ; t < n_threads ; t++ ) { accumulate_status( thread_params[t]->status ); }
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "thread %i knows threads %i through %i are done evaluating.\n" , 1 , 2 , n_threads );
+		pthread_mutex_unlock( &prntlock );
+	}
+}
+
+void pthreader::evaluate_tree( void * in , void * out )
+{
+	int g , bits;
+	pthreader_params * p;
+
+	// publish the job, then open the generation for our own children only; they pass it on
+	shared->job.thread_eval = thread_eval;
+	shared->job.eval_in  = in;
+	shared->job.eval_out = out;
+	g = ++(shared->epoch.value);
+	pthreader_tree_wake( thread_params , 0 , n_threads , g );
+
+	p = thread_params[0];
+	p->status = thread_eval( 0 , p->eval_params , in , out );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "thread %i is done evaluating.\n" , 1 );
+		pthread_mutex_unlock( &prntlock );
+	}
+
+	// our children report for their whole subtrees, status included
+	bits  = pthreader_status_bit( p->status );
+	bits |= pthreader_tree_join( thread_params , 0 , n_threads , g );
+	accumulate_status_bits( bits );
+
+	if( verbose ) {
+		pthread_mutex_lock( &prntlock );
+		printf( "thread %i knows threads %i through %i are done evaluating.\n" , 1 , 2 , n_threads );
+		pthread_mutex_unlock( &prntlock );
+	}
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -597,61 +1149,99 @@ void pthreader::close( )
 		pthread_mutex_unlock( &prntlock );
 	}
 
+	switch( dispatch ) {
+		case PTHREADER_DISPATCH_EPOCH : close_epoch(); break;
+		case PTHREADER_DISPATCH_TREE  : close_tree(); break;
+		default : close_condvar(); break;
+	}
+
+	// clear pointers in the thread_params objects
+	for( t = 0 ; t < n_threads ; t++ ) {
+		thread_params[t]->init_data   = NULL;
+		thread_params[t]->eval_params = NULL;
+		thread_params[t]->eval_in 	  = NULL;
+		thread_params[t]->eval_out 	  = NULL;
+	}
+
+	// free the thread objects
+	free( thread );
+
+	// set the running flag back to "no"
+	threads_open = 0;
+
+}
+
+void pthreader::close_condvar( ) 
+{
+	int t;
+	pthreader_params * p;
+
 	// signal each thread that it needs to stop working, clean up, and shut down
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
-		pthread_mutex_lock( worklock + t );
-		if( workflag[t] == 1 ) {
-			pthread_cond_wait( cv_free + t , worklock + t );
+	for( t = 1 ; t < n_threads ; t++ ) {
+		p = thread_params[t];
+		pthread_mutex_lock( &(p->worklock) );
+		while( p->work == 1 ) {
+			pthread_cond_wait( &(p->cv_free) , &(p->worklock) );
 		}
-		thread_params[t].exit = 1; // set exit flag in the data structure accessed by worker thread t+1
-		workflag[t] = 1;
-		pthread_cond_signal( cv_work + t );
-		pthread_mutex_unlock( worklock + t );
+		p->exit = 1; // set exit flag in the data structure accessed by worker thread t
+		pthreader_store( &(p->work) , 1 );
+		pthread_cond_signal( &(p->cv_work) );
+		pthread_mutex_unlock( &(p->worklock) );
 	}
 
 	// do cleanup here too... 
-	if( thread_free != NULL ) { thread_free( 0 , &eval_params ); }
+	if( thread_free != NULL ) { thread_free( 0 , &(thread_params[0]->eval_params) ); }
 
 	// join threads and cleanup infrastructure
-	for( t = 0 ; t < n_threads_minus_one ; t++ ) {
+	for( t = 1 ; t < n_threads ; t++ ) {
+
+		p = thread_params[t];
 
 		// destroy the threads by joining with this one
-		pthread_join( thread[t] , NULL );
+		pthread_join( thread[t-1] , NULL );
 
 		// cleanup after pthreads
-		pthread_mutex_destroy( worklock + t );
-		pthread_cond_destroy( cv_work + t );
-		pthread_cond_destroy( cv_free + t );
+		pthread_mutex_destroy( &(p->worklock) );
+		pthread_cond_destroy( &(p->cv_work) );
+		pthread_cond_destroy( &(p->cv_free) );
 
-		// clear pointers in the thread_params objects
-		thread_params[t].workflag 	 = NULL;
-		thread_params[t].worklock 	 = NULL;
-		thread_params[t].cv_work  	 = NULL;
-		thread_params[t].cv_free  	 = NULL;
-		thread_params[t].init_data 	 = NULL;
-		thread_params[t].eval_params = NULL;
-		thread_params[t].eval_in 	 = NULL;
-		thread_params[t].eval_out 	 = NULL;
+		p->exit = 0;
+		p->work = 0;
 
 	}
 
-	// free the workflag list allocated by launch()
-	free( workflag );
+}
+
+void pthreader::close_epoch( ) 
+{
+	int t;
 
-	// free the status flags
-	free( statflag );
+	// the last generation tells every thread to clean up and exit
+	shared->job.exit = 1;
+	pthreader_post( &(shared->epoch) , shared->epoch.value + 1 );
 
-	// free thread coordination stuff
-	free( worklock );
-	free( cv_work  );
-	free( cv_free  );
-	free( thread   );
+	if( thread_free != NULL ) { thread_free( 0 , &(thread_params[0]->eval_params) ); }
 
-	// set the running flag back to "no"
-	threads_open = 0;
+	for( t = 1 ; t < n_threads ; t++ ) { pthread_join( thread[t-1] , NULL ); }
 
 }
 
+void pthreader::close_tree( )
+{
+	int t , g;
+
+	// the exit generation travels down the tree like any other
+	shared->job.exit = 1;
+	g = ++(shared->epoch.value);
+	pthreader_tree_wake( thread_params , 0 , n_threads , g );
+
+	if( thread_free != NULL ) { thread_free( 0 , &(thread_params[0]->eval_params) ); }
+
+	for( t = 1 ; t < n_threads ; t++ ) { pthread_join( thread[t-1] , NULL ); }
+
+}
+
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
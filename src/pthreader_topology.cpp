@@ -0,0 +1,303 @@
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+#include "pthreader.h"
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * TOPOLOGY DISCOVERY
+ * 
+ * read the cpus we are allowed to run on from sched_getaffinity, and where each one sits (core, package
+ * and NUMA node) from sysfs. Anything we can't read is treated as its own core on package and node 0.
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// read a single integer from a (sysfs) file, returning 0 on success
+static int pthreader_read_int( const char * path , long * v )
+{
+	FILE * fp = fopen( path , "r" );
+	if( fp == NULL ) { return 1; }
+	int r = ( fscanf( fp , "%li" , v ) == 1 ? 0 : 1 );
+	fclose( fp );
+	return r;
+}
+
+// the NUMA node a cpu belongs to, from the "nodeN" link in its sysfs directory
+static int pthreader_cpu_node( int cpu )
+{
+#ifdef __linux__
+	char path[128];
+	struct dirent * e;
+	int node = 0;
+	snprintf( path , 128 , "/sys/devices/system/cpu/cpu%i" , cpu );
+	DIR * d = opendir( path );
+	if( d == NULL ) { return 0; }
+	while( ( e = readdir( d ) ) != NULL ) {
+		if( strncmp( e->d_name , "node" , 4 ) == 0 && e->d_name[4] >= '0' && e->d_name[4] <= '9' ) {
+			node = atoi( e->d_name + 4 );
+			break;
+		}
+	}
+	closedir( d );
+	return node;
+#else
+	return 0;
+#endif
+}
+
+// count distinct values of one field over the cpus (fields are small, non-negative ints)
+static int pthreader_count_distinct( const pthreader_topology * topo , int field )
+{
+	int i , j , n = 0 , a , b , seen;
+	for( i = 0 ; i < topo->n_cpus ; i++ ) {
+		seen = 0;
+		for( j = 0 ; j < i && ! seen ; j++ ) {
+			switch( field ) {
+				case 0  : a = topo->cpus[i].package; b = topo->cpus[j].package; break;
+				case 1  : a = topo->cpus[i].node;    b = topo->cpus[j].node;    break;
+				default : // cores are only distinct within a package
+					a = ( topo->cpus[i].package == topo->cpus[j].package ? topo->cpus[i].core : -1 );
+					b = topo->cpus[j].core;
+					break;
+			}
+			seen = ( a == b );
+		}
+		if( ! seen ) { n++; }
+	}
+	return n;
+}
+
+int pthreader_topology_discover( pthreader_topology * topo )
+{
+	int c , n = 0;
+	long v;
+	char path[128];
+
+	if( topo == NULL ) { return 1; }
+	topo->n_cpus = 0;
+	topo->cpus = NULL;
+
+#ifdef __linux__
+	cpu_set_t mask;
+	CPU_ZERO( &mask );
+	if( sched_getaffinity( 0 , sizeof( cpu_set_t ) , &mask ) != 0 ) { return 1; }
+
+	topo->cpus = ( pthreader_cpu * )malloc( CPU_COUNT( &mask ) * sizeof( pthreader_cpu ) );
+	if( topo->cpus == NULL ) { return 1; }
+
+	for( c = 0 ; c < CPU_SETSIZE && n < CPU_COUNT( &mask ) ; c++ ) {
+
+		if( ! CPU_ISSET( c , &mask ) ) { continue; }
+
+		topo->cpus[n].cpu = c;
+
+		snprintf( path , 128 , "/sys/devices/system/cpu/cpu%i/topology/core_id" , c );
+		topo->cpus[n].core = ( pthreader_read_int( path , &v ) == 0 ? (int)v : c );
+
+		snprintf( path , 128 , "/sys/devices/system/cpu/cpu%i/topology/physical_package_id" , c );
+		topo->cpus[n].package = ( pthreader_read_int( path , &v ) == 0 && v >= 0 ? (int)v : 0 );
+
+		topo->cpus[n].node = pthreader_cpu_node( c );
+
+		n++;
+
+	}
+#endif
+
+	topo->n_cpus     = n;
+	topo->n_packages = pthreader_count_distinct( topo , 0 );
+	topo->n_nodes    = pthreader_count_distinct( topo , 1 );
+	topo->n_cores    = pthreader_count_distinct( topo , 2 );
+
+	return ( n > 0 ? 0 : 1 );
+}
+
+void pthreader_topology_free( pthreader_topology * topo )
+{
+	if( topo == NULL ) { return; }
+	free( topo->cpus );
+	topo->cpus = NULL;
+	topo->n_cpus = 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * DEFAULT THREAD COUNT
+ * 
+ * the cpus in our affinity mask, capped by any cgroup cpu quota (v2 "cpu.max", or v1 "cpu.cfs_quota_us"
+ * and "cpu.cfs_period_us"); a container allowed 4 cpus' worth of time on a 64 cpu host gets 4 threads
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// cpus' worth of quota from a cgroup v2 "cpu.max" file ("max 100000" or "200000 100000"), 0 if unlimited
+static double pthreader_cgroup2_quota( const char * path )
+{
+	char quota[32];
+	long period;
+	double q = 0.0;
+	FILE * fp = fopen( path , "r" );
+	if( fp == NULL ) { return -1.0; }
+	if( fscanf( fp , "%31s %li" , quota , &period ) == 2 && strcmp( quota , "max" ) != 0 && period > 0 ) {
+		q = strtod( quota , NULL ) / ((double)period);
+	}
+	fclose( fp );
+	return q;
+}
+
+// cpus' worth of quota for this process's cgroup, 0 if unlimited (or unknown)
+static double pthreader_cgroup_quota()
+{
+	char line[512] , path[640];
+	double q;
+	long quota , period;
+	FILE * fp;
+
+	// cgroup v2: our group is the "0::" line in /proc/self/cgroup
+	fp = fopen( "/proc/self/cgroup" , "r" );
+	if( fp != NULL ) {
+		while( fgets( line , 512 , fp ) != NULL ) {
+			if( strncmp( line , "0::" , 3 ) == 0 ) {
+				line[ strcspn( line , "\n" ) ] = '\0';
+				snprintf( path , 640 , "/sys/fs/cgroup%s/cpu.max" , line + 3 );
+				q = pthreader_cgroup2_quota( path );
+				if( q >= 0.0 ) { fclose( fp ); return q; }
+			}
+		}
+		fclose( fp );
+	}
+
+	// inside a container the group is often mounted as the root
+	q = pthreader_cgroup2_quota( "/sys/fs/cgroup/cpu.max" );
+	if( q >= 0.0 ) { return q; }
+
+	// cgroup v1
+	if( pthreader_read_int( "/sys/fs/cgroup/cpu/cpu.cfs_quota_us" , &quota ) == 0
+			&& pthreader_read_int( "/sys/fs/cgroup/cpu/cpu.cfs_period_us" , &period ) == 0
+			&& quota > 0 && period > 0 ) {
+		return ((double)quota) / ((double)period);
+	}
+
+	return 0.0;
+}
+
+int pthreader_default_threads()
+{
+	int n = 1;
+	double q;
+
+#ifdef __linux__
+	cpu_set_t mask;
+	CPU_ZERO( &mask );
+	if( sched_getaffinity( 0 , sizeof( cpu_set_t ) , &mask ) == 0 ) { n = CPU_COUNT( &mask ); }
+#endif
+
+	q = pthreader_cgroup_quota();
+	if( q > 0.0 && ceil( q ) < (double)n ) { n = (int)ceil( q ); }
+
+	return ( n > 0 ? n : 1 );
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * PLACEMENT ORDERS
+ * 
+ * each placement is an ordering of the usable cpus; thread t gets the (t mod n_cpus)'th
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// compact order: node, package, core, then cpu, so consecutive threads share as much cache as possible
+static int pthreader_compare_compact( const void * a , const void * b )
+{
+	const pthreader_cpu * x = ( const pthreader_cpu * )a , * y = ( const pthreader_cpu * )b;
+	if( x->node    != y->node    ) { return x->node    - y->node;    }
+	if( x->package != y->package ) { return x->package - y->package; }
+	if( x->core    != y->core    ) { return x->core    - y->core;    }
+	return x->cpu - y->cpu;
+}
+
+// move the first cpu of every core to the front (keeping compact order within both halves)
+static void pthreader_cores_first( pthreader_cpu * cpus , int n )
+{
+	int i , k = 0;
+	pthreader_cpu * tmp = ( pthreader_cpu * )malloc( n * sizeof( pthreader_cpu ) );
+	char * first = ( char * )malloc( n );
+	if( tmp == NULL || first == NULL ) { free( tmp ); free( first ); return; }
+	for( i = 0 ; i < n ; i++ ) {
+		first[i] = ( i == 0 || cpus[i].package != cpus[i-1].package || cpus[i].core != cpus[i-1].core );
+		if( first[i] ) { tmp[k++] = cpus[i]; }
+	}
+	for( i = 0 ; i < n ; i++ ) { if( ! first[i] ) { tmp[k++] = cpus[i]; } }
+	memcpy( cpus , tmp , n * sizeof( pthreader_cpu ) );
+	free( tmp );
+	free( first );
+}
+
+// deal the cores-first order out round-robin over NUMA nodes, so consecutive threads land on different nodes
+static void pthreader_scatter( pthreader_cpu * cpus , int n )
+{
+	int i , k = 0 , last;
+	pthreader_cpu * tmp = ( pthreader_cpu * )malloc( n * sizeof( pthreader_cpu ) );
+	char * used = ( char * )calloc( n , 1 );
+	if( tmp == NULL || used == NULL ) { free( tmp ); free( used ); return; }
+	while( k < n ) {
+		// one pass takes the first unused cpu from each node in turn (cpus are sorted by node)
+		last = -1;
+		for( i = 0 ; i < n ; i++ ) {
+			if( used[i] || cpus[i].node <= last ) { continue; }
+			tmp[k++] = cpus[i]; used[i] = 1; last = cpus[i].node;
+		}
+	}
+	memcpy( cpus , tmp , n * sizeof( pthreader_cpu ) );
+	free( tmp );
+	free( used );
+}
+
+int pthreader_placement_order( pthreader_placement p , pthreader_topology * topo )
+{
+	if( topo == NULL || topo->n_cpus <= 0 ) { return 1; }
+	qsort( topo->cpus , topo->n_cpus , sizeof( pthreader_cpu ) , pthreader_compare_compact );
+	switch( p ) {
+		case PTHREADER_PLACE_COMPACT : break;
+		case PTHREADER_PLACE_CORES   : pthreader_cores_first( topo->cpus , topo->n_cpus ); break;
+		case PTHREADER_PLACE_SCATTER :
+			pthreader_cores_first( topo->cpus , topo->n_cpus );
+			pthreader_scatter( topo->cpus , topo->n_cpus );
+			break;
+		default : return 1;
+	}
+	return 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * 
+ * Copyright 2018+, W. Ross Morrow, Stanford GSB Research Support Services
+ * 
+ * https://code.stanford.edu/morrowwr/pthreader
+ *
+ * wrossmorrow@stanford.edu, morrowwr@gmail.com
+ * 
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */